@@ -0,0 +1,44 @@
+#ifndef AGENT_H
+#define AGENT_H
+
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+#include "system.h"
+
+/*
+Serves the System of this host to aggregators, see include/protocol.h.
+Runs a single-threaded loop: once per tick it samples the system, then
+sends every subscribed client the changes since its last update.
+*/
+class Agent {
+ public:
+  Agent(System& system, std::string const& name)
+      : system_(system), name_(name){};
+
+  bool Listen(std::string const& address);  // See src/agent.cpp
+  void Run();                               // See src/agent.cpp
+
+ private:
+  struct Client {
+    int fd{-1};
+    int top{0};  // 0 until the client subscribes
+    std::string received;
+    Protocol::Snapshot sent;
+    bool synchronized{false};  // a full snapshot has been sent
+  };
+
+  Protocol::Snapshot Sample(int top);
+  void Accept(int listener);
+  void Prune();
+  bool Receive(Client& client);
+  bool Send(Client& client, Protocol::Snapshot const& snapshot);
+
+  System& system_;
+  std::string name_;
+  std::vector<int> listeners_;
+  std::vector<Client> clients_;
+};
+
+#endif
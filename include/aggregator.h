@@ -0,0 +1,53 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+/*
+Keeps the latest snapshot of every agent, see include/protocol.h, and
+merges their top processes into a single ranking. Nothing here blocks the
+caller beyond the time given to Poll: connections are made without waiting,
+and agents that are down are retried with an exponential backoff.
+*/
+class Aggregator {
+ public:
+  struct Source {
+    std::string address;
+    std::vector<Protocol::Endpoint> endpoints;  // resolved on first use
+    size_t next_endpoint{0};
+    int fd{-1};
+    bool connecting{false};
+    int failures{0};  // consecutive, for the retry backoff
+    std::chrono::steady_clock::time_point retry;    // next connection attempt
+    std::chrono::steady_clock::time_point timeout;  // of the current attempt
+    std::string received;
+    Protocol::Snapshot snapshot;
+    bool Connected() const { return fd >= 0 && !connecting; }
+  };
+  struct HostProcess {
+    std::string host;
+    Protocol::ProcessRecord process;
+    long uptime{0};  // seconds
+  };
+
+  Aggregator(std::vector<std::string> const& addresses, int top);
+
+  void Poll(int milliseconds);                 // See src/aggregator.cpp
+  std::vector<Source> const& Sources() const;  // See src/aggregator.cpp
+  std::vector<HostProcess> Top(int n) const;   // See src/aggregator.cpp
+
+ private:
+  void Connect(Source& source);
+  bool Subscribe(Source& source);
+  bool Receive(Source& source);
+  void Disconnect(Source& source);
+
+  int top_;
+  std::vector<Source> sources_;
+};
+
+#endif
@@ -3,22 +3,35 @@
 
 #include <fstream>
 #include <regex>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace LinuxParser {
 // Paths
-const std::string kProcDirectory{"/proc/"};
+// The procfs root defaults to /proc/ and can point at a copy of another
+// host's /proc, e.g. to run several agents side by side.
+std::string const& ProcDirectory();
+void SetProcDirectory(std::string const& path);
 const std::string kCmdlineFilename{"/cmdline"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
 const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
+const std::string kSchedstatFilename{"/schedstat"};
+const std::string kTaskDirectory{"/task/"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
+const std::string kLoadavgFilename{"/loadavg"};
+const std::string kPressureDirectory{"/pressure/"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
 
 // System
+// ReadCached reads each file at most once between two calls to NextTick,
+// which the refresh loop makes once per tick
+void NextTick();
+bool ReadCached(std::string const& path, std::istringstream& stream);
 float MemoryUtilization();
 long UpTime();
 std::vector<int> Pids();
@@ -26,6 +39,29 @@ int TotalProcesses();
 int RunningProcesses();
 std::string OperatingSystem();
 std::string Kernel();
+// Counters from /proc/stat
+struct StatCounters {
+  long context_switches{0};  // since boot
+  long interrupts{0};        // since boot
+  int blocked_processes{0};  // currently waiting on I/O
+};
+StatCounters Counters();
+std::vector<float> LoadAverages();
+
+// Pressure Stall Information
+// Averages are percentages of wall time, total is cumulative stall in us.
+struct PressureLine {
+  float avg10{0};
+  float avg60{0};
+  float avg300{0};
+  long total{0};
+};
+struct Pressure {
+  bool available{false};
+  PressureLine some;  // at least one task stalled
+  PressureLine full;  // all non-idle tasks stalled
+};
+Pressure PressureStall(std::string const& resource);
 
 // CPU
 enum CPUStates {
@@ -49,11 +85,50 @@ long IdleJiffies();
 // Processes
 // TODO: Create an enum of process states
 // TODO: Create a ProcessUtilization function
+// Fields of /proc/<pid>/task/<tid>/schedstat, all cumulative since the
+// thread started
+enum SchedstatFields {
+  kRunTime_ = 0,  // ns spent on a CPU
+  kWaitTime_,     // ns spent runnable on a run queue
+  kTimeslices_    // number of timeslices run on a CPU
+};
+// The /proc/<pid>/status fields we use, parsed in a single pass
+struct ProcessStatus {
+  std::string uid;
+  std::string ram;
+};
+// Scheduler counters summed over the live threads of a process; the
+// per-process schedstat and status files describe the main thread only
+struct SchedulerCounters {
+  std::vector<long> schedstat{0, 0, 0};  // indexed by SchedstatFields
+  long voluntary_ctxt_switches{0};
+  long nonvoluntary_ctxt_switches{0};
+};
+// The /proc/<pid>/stat fields we use, all times in clock ticks
+struct ProcessStat {
+  bool available{false};
+  int pid{0};
+  std::string comm;  // process name, truncated to 15 characters
+  long utime{0};
+  long stime{0};
+  long cutime{0};
+  long cstime{0};
+  long starttime{0};
+  long vsize{0};  // bytes
+};
+ProcessStat Stat(int pid);
+std::string OwnerUid(int pid);
+ProcessStatus Status(int pid);
+std::vector<int> Tasks(int pid);
+SchedulerCounters Scheduler(int pid);
 std::string Command(int pid);
 std::string Ram(int pid);
 std::string Uid(int pid);
 std::string User(int pid);
+std::string UserName(std::string const& uid);
+std::string UserId(std::string const& name);
 long int UpTime(int pid);
 float ProcessUtilization(int pid);
+float ProcessUtilization(ProcessStat const& stat);
 };  // namespace LinuxParser
 #endif
\ No newline at end of file
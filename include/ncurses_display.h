@@ -3,14 +3,26 @@
 
 #include <curses.h>
 
+#include "aggregator.h"
 #include "process.h"
+#include "process_filter.h"
 #include "system.h"
 
 namespace NCursesDisplay {
 void Display(System& system, int n = 10);
 void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
+void DisplayLoad(System& system, WINDOW* window);
+void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n,
+                      bool scheduler_columns = false);
+void DisplayFilter(ProcessFilter const& filter, WINDOW* window);
+void EditFilter(ProcessFilter& filter, WINDOW* window, int key);
+std::string Prompt(WINDOW* window, std::string const& label);
 std::string ProgressBar(float percent);
+void Display(Aggregator& aggregator, int n = 10);
+void DisplayHosts(Aggregator const& aggregator, WINDOW* window);
+void DisplayHostProcesses(
+    std::vector<Aggregator::HostProcess> const& processes, WINDOW* window,
+    int n);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define PROCESS_H
 
 #include <string>
+#include <vector>
+
+#include "linux_parser.h"
 /*
 Basic class for Process representation
 It contains relevant attributes as shown below
@@ -10,17 +13,38 @@ class Process {
  public:
   Process(int pid) : pid_(pid){};
 
+  void Update(LinuxParser::ProcessStat const& stat);  // See src/process.cpp
+
   int Pid() const;                         // TODO: See src/process.cpp
+  long StartTime() const;                  // See src/process.cpp
   std::string User();                      // TODO: See src/process.cpp
   std::string Command();                   // TODO: See src/process.cpp
   float CpuUtilization() const;            // TODO: See src/process.cpp
   std::string Ram();                       // TODO: See src/process.cpp
   long int UpTime();                       // TODO: See src/process.cpp
+  long RunTime() const;                    // See src/process.cpp
+  long WaitTime() const;                   // See src/process.cpp
+  long Timeslices() const;                 // See src/process.cpp
+  long VoluntarySwitches() const;          // See src/process.cpp
+  long NonvoluntarySwitches() const;       // See src/process.cpp
   bool operator<(Process const& a) const;  // TODO: See src/process.cpp
 
   // TODO: Declare any necessary private members
  private:
   int pid_;
+  bool sampled_{false};
+  long start_time_{0};  // clock ticks after boot, tells reused PIDs apart
+  float cpu_{0};
+  std::string uid_;
+  std::string ram_;
+  // Cumulative counters from the last Update, and their change over the
+  // interval that ended with it
+  std::vector<long> schedstat_{0, 0, 0};
+  std::vector<long> schedstat_delta_{0, 0, 0};
+  long voluntary_switches_{0};
+  long voluntary_switches_delta_{0};
+  long nonvoluntary_switches_{0};
+  long nonvoluntary_switches_delta_{0};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,47 @@
+#ifndef PROCESS_FILTER_H
+#define PROCESS_FILTER_H
+
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+Criteria deciding which processes System samples. Checks are split by cost
+so that a process can be dropped before any file of it is read: the PID
+list needs nothing, the user needs a stat(2) of /proc/<pid> and, for the
+processes procfs shows as root's, /proc/<pid>/status, and the CPU/RAM
+thresholds need only /proc/<pid>/stat. The name criteria match the comm
+field of stat, which the kernel truncates to 15 characters. The command line
+criterion is the one that costs a read of /proc/<pid>/cmdline for each
+process that passes every other criterion, whether it is then kept or not.
+*/
+class ProcessFilter {
+ public:
+  void User(std::string const& name);
+  void Name(std::string const& substring);
+  void NameRegex(std::string const& pattern);  // Throws std::regex_error
+  void CommandLine(std::string const& substring);
+  void Pids(std::vector<int> const& pids);
+  void MinCpuUtilization(float percent);
+  void MinRam(float megabytes);
+  void Clear();
+  std::string Description() const;
+  bool Admits(int pid) const;
+  bool Admits(LinuxParser::ProcessStat const& stat) const;
+
+ private:
+  std::string user_;
+  std::string uid_;
+  std::string name_;
+  std::string pattern_;
+  std::string command_line_;
+  std::regex regex_;
+  std::unordered_set<int> pids_;
+  float min_cpu_{0};
+  float min_ram_{0};
+};
+
+#endif
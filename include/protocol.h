@@ -0,0 +1,78 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <sys/socket.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Binary protocol between an agent, which serves the System of its host, and
+an aggregator, which merges the snapshots of many agents.
+
+Every frame is a varint length, a type byte and a payload. Integers are
+LEB128 varints and strings are a varint length followed by the bytes. The
+aggregator subscribes with the number of processes it wants; the agent then
+sends one full snapshot followed by one delta per tick. A delta carries the
+host summary, the records that are new or changed, the PIDs that left the
+top, and the new ranking as a list of PIDs.
+*/
+namespace Protocol {
+enum FrameType { kSubscribe_ = 1, kSnapshot_, kDelta_ };
+enum FrameStatus { kFrameIncomplete_ = 0, kFrameComplete_, kFrameMalformed_ };
+
+// Values are quantized on the wire: CPU and memory to 0.01%, RAM to 0.1 MB.
+struct HostRecord {
+  std::string name;
+  float cpu{0};     // fraction of all CPUs
+  float memory{0};  // fraction of physical memory
+  int total_processes{0};
+  int running_processes{0};
+  long uptime{0};  // seconds
+};
+struct ProcessRecord {
+  int pid{0};
+  float cpu{0};   // fraction of one CPU over the process lifetime
+  float ram{0};   // MB
+  long start{0};  // seconds after boot
+  std::string user;
+  std::string command;
+};
+// Processes are ranked by descending CPU utilization
+struct Snapshot {
+  HostRecord host;
+  std::vector<ProcessRecord> processes;
+};
+
+// Encoding
+void PutVarint(std::string& buffer, uint64_t value);
+void PutString(std::string& buffer, std::string const& value);
+std::string Frame(FrameType type, std::string const& payload);
+std::string EncodeSubscribe(int top);
+std::string EncodeUpdate(Snapshot const& previous, Snapshot const& current,
+                         bool full);
+
+// Decoding
+bool GetVarint(std::string const& buffer, size_t& offset, uint64_t& value);
+bool GetString(std::string const& buffer, size_t& offset, std::string& value);
+FrameStatus NextFrame(std::string& buffer, FrameType& type,
+                      std::string& payload);
+bool DecodeSubscribe(std::string const& payload, int& top);
+bool ApplyUpdate(std::string const& payload, bool full, Snapshot& snapshot);
+
+// Sockets
+// Addresses are "unix:<path>" or "<host>:<port>", with IPv6 hosts in
+// brackets. An empty host is loopback, both ::1 and 127.0.0.1; listening on
+// every interface needs an explicit 0.0.0.0 or [::]. Listen binds every
+// address the host resolves to and returns no socket on failure; Connect
+// returns -1 on failure.
+struct Endpoint {
+  sockaddr_storage address;
+  socklen_t length{0};
+};
+std::vector<Endpoint> Resolve(std::string const& address);
+std::vector<int> Listen(std::string const& address);
+int Connect(Endpoint const& endpoint);
+};  // namespace Protocol
+
+#endif
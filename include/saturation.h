@@ -0,0 +1,43 @@
+#ifndef SATURATION_H
+#define SATURATION_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+System-wide saturation: load averages, blocked processes, Pressure Stall
+Information and the context switch / interrupt rates between two ticks
+*/
+class Saturation {
+ public:
+  enum PressureResource { kCpuPressure_ = 0, kMemoryPressure_, kIoPressure_ };
+
+  void Update();                                  // See src/saturation.cpp
+  std::vector<float> LoadAverages() const;        // See src/saturation.cpp
+  int BlockedProcesses() const;                   // See src/saturation.cpp
+  float ContextSwitchRate() const;                // See src/saturation.cpp
+  float InterruptRate() const;                    // See src/saturation.cpp
+  LinuxParser::Pressure const& Stall(PressureResource resource) const;
+  float SomeStallRate(PressureResource resource) const;
+  float FullStallRate(PressureResource resource) const;
+
+ private:
+  const std::vector<std::string> resources_{"cpu", "memory", "io"};
+  bool sampled_{false};
+  std::chrono::steady_clock::time_point time_;
+  float interval_{0};  // seconds between the last two Updates
+  std::vector<float> load_averages_{0, 0, 0};
+  int blocked_processes_{0};
+  long context_switches_{0};
+  long context_switches_delta_{0};
+  long interrupts_{0};
+  long interrupts_delta_{0};
+  std::vector<LinuxParser::Pressure> pressure_{3};
+  std::vector<long> some_stall_delta_{0, 0, 0};
+  std::vector<long> full_stall_delta_{0, 0, 0};
+};
+
+#endif
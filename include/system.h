@@ -5,11 +5,18 @@
 #include <vector>
 
 #include "process.h"
+#include "process_filter.h"
 #include "processor.h"
+#include "saturation.h"
 
 class System {
  public:
+  // Orderings for the process table
+  enum SortKey { kCpuSort_ = 0, kWaitTimeSort_ };
+
   Processor& Cpu();                   // TODO: See src/system.cpp
+  Saturation& Load();                 // See src/system.cpp
+  ProcessFilter& Filter();            // See src/system.cpp
   std::vector<Process>& Processes();  // TODO: See src/system.cpp
   float MemoryUtilization();          // TODO: See src/system.cpp
   long UpTime();                      // TODO: See src/system.cpp
@@ -17,11 +24,16 @@ class System {
   int RunningProcesses();             // TODO: See src/system.cpp
   std::string Kernel();               // TODO: See src/system.cpp
   std::string OperatingSystem();      // TODO: See src/system.cpp
+  void SortBy(SortKey key);           // See src/system.cpp
+  SortKey SortOrder() const;          // See src/system.cpp
 
   // DONE: Define any necessary private members
  private:
   Processor cpu_ = {};
+  Saturation load_ = {};
   std::vector<Process> processes_ = {};
+  SortKey sort_key_ = kCpuSort_;
+  ProcessFilter filter_ = {};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "agent.h"
+#include "linux_parser.h"
+#include "protocol.h"
+#include "system.h"
+
+using std::string;
+using std::vector;
+
+// DONE: Open the socket aggregators connect to
+bool Agent::Listen(string const& address) {
+  listeners_ = Protocol::Listen(address);
+  return !listeners_.empty();
+}
+
+// DONE: Sample and publish once per second until killed
+// Between ticks the loop accepts new clients and reads their subscriptions.
+void Agent::Run() {
+  auto next_tick = std::chrono::steady_clock::now();
+  while (true) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_tick) {
+      int top{0};
+      for (auto const& client : clients_) top = std::max(top, client.top);
+      if (top > 0) {
+        Protocol::Snapshot snapshot = Sample(top);
+        for (auto& client : clients_) {
+          if (client.top > 0 && !Send(client, snapshot)) {
+            close(client.fd);
+            client.fd = -1;
+          }
+        }
+      }
+      // Skip the ticks missed by a sample slower than the interval
+      next_tick = std::max(next_tick + std::chrono::seconds(1),
+                           std::chrono::steady_clock::now());
+      Prune();
+      continue;
+    }
+
+    // Clients first, then the listeners
+    vector<pollfd> fds;
+    for (auto const& client : clients_) fds.push_back({client.fd, POLLIN, 0});
+    for (int listener : listeners_) fds.push_back({listener, POLLIN, 0});
+    int timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      next_tick - now)
+                      .count();
+    if (poll(fds.data(), fds.size(), timeout) <= 0) continue;
+
+    size_t client_count = clients_.size();
+    for (size_t i = 0; i < client_count; i++) {
+      if (fds[i].revents != 0 && !Receive(clients_[i])) {
+        close(clients_[i].fd);
+        clients_[i].fd = -1;
+      }
+    }
+    Prune();
+    for (size_t i = client_count; i < fds.size(); i++) {
+      if (fds[i].revents & POLLIN) Accept(fds[i].fd);
+    }
+  }
+}
+
+// DONE: Forget the clients whose connection has been closed
+void Agent::Prune() {
+  clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
+                                [](Client const& client) {
+                                  return client.fd < 0;
+                                }),
+                 clients_.end());
+}
+
+// DONE: Take a snapshot of the system and its top processes
+// Users and commands are read for the top processes only.
+Protocol::Snapshot Agent::Sample(int top) {
+  LinuxParser::NextTick();
+  Protocol::Snapshot snapshot;
+  snapshot.host.name = name_;
+  snapshot.host.cpu = system_.Cpu().Utilization();
+  snapshot.host.memory = system_.MemoryUtilization();
+  snapshot.host.total_processes = system_.TotalProcesses();
+  snapshot.host.running_processes = system_.RunningProcesses();
+  snapshot.host.uptime = system_.UpTime();
+
+  vector<Process>& processes = system_.Processes();
+  for (int i = 0; i < top && i < static_cast<int>(processes.size()); i++) {
+    Protocol::ProcessRecord record;
+    record.pid = processes[i].Pid();
+    record.cpu = processes[i].CpuUtilization();
+    record.ram = processes[i].Ram().empty() ? 0 : std::stof(processes[i].Ram());
+    record.start = processes[i].StartTime() / sysconf(_SC_CLK_TCK);
+    record.user = processes[i].User();
+    record.command = processes[i].Command().substr(0, 255);
+    snapshot.processes.push_back(record);
+  }
+  return snapshot;
+}
+
+// DONE: Accept a pending connection on a listener
+void Agent::Accept(int listener) {
+  int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0) return;
+  Client client;
+  client.fd = fd;
+  clients_.push_back(client);
+}
+
+// DONE: Read a client's subscription, returning false once it has gone
+bool Agent::Receive(Client& client) {
+  char buffer[512];
+  ssize_t count = recv(client.fd, buffer, sizeof(buffer), 0);
+  if (count == 0) return false;
+  if (count < 0) return errno == EAGAIN || errno == EINTR;
+  client.received.append(buffer, count);
+
+  Protocol::FrameType type;
+  string payload;
+  Protocol::FrameStatus status;
+  while ((status = Protocol::NextFrame(client.received, type, payload)) ==
+         Protocol::kFrameComplete_) {
+    if (type != Protocol::kSubscribe_ ||
+        !Protocol::DecodeSubscribe(payload, client.top))
+      return false;
+  }
+  return status != Protocol::kFrameMalformed_;
+}
+
+// DONE: Send the changes since the client's last update
+// Frames are small, so a socket buffer too full to take one means the
+// client has stopped reading and is dropped.
+bool Agent::Send(Client& client, Protocol::Snapshot const& snapshot) {
+  Protocol::Snapshot current{snapshot.host, {}};
+  int top = std::min<int>(client.top, snapshot.processes.size());
+  current.processes.assign(snapshot.processes.begin(),
+                           snapshot.processes.begin() + top);
+
+  string frame =
+      Protocol::EncodeUpdate(client.sent, current, !client.synchronized);
+  size_t offset{0};
+  while (offset < frame.size()) {
+    ssize_t count = send(client.fd, frame.data() + offset,
+                         frame.size() - offset, MSG_NOSIGNAL);
+    if (count < 0 && errno == EINTR) continue;
+    if (count <= 0) return false;
+    offset += count;
+  }
+  client.sent = current;
+  client.synchronized = true;
+  return true;
+}
@@ -0,0 +1,175 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "aggregator.h"
+#include "protocol.h"
+
+using std::string;
+using std::vector;
+
+Aggregator::Aggregator(vector<string> const& addresses, int top) : top_(top) {
+  for (auto const& address : addresses) {
+    Source source;
+    source.address = address;
+    sources_.push_back(source);
+  }
+}
+
+// DONE: Receive updates from every agent for the given time
+// Also completes pending connections and starts the retries that are due.
+void Aggregator::Poll(int milliseconds) {
+  auto now = std::chrono::steady_clock::now();
+  for (auto& source : sources_) {
+    if (source.fd < 0 && now >= source.retry) Connect(source);
+  }
+
+  auto deadline = now + std::chrono::milliseconds(milliseconds);
+  while (true) {
+    now = std::chrono::steady_clock::now();
+    for (auto& source : sources_) {
+      if (source.connecting && now >= source.timeout) Disconnect(source);
+    }
+    auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+    if (remaining.count() <= 0) return;
+
+    vector<pollfd> fds;
+    vector<Source*> polled;
+    for (auto& source : sources_) {
+      if (source.fd < 0) continue;
+      short events = source.connecting ? POLLOUT : POLLIN;
+      fds.push_back({source.fd, events, 0});
+      polled.push_back(&source);
+    }
+    if (fds.empty()) {
+      poll(nullptr, 0, remaining.count());
+      return;
+    }
+    if (poll(fds.data(), fds.size(), remaining.count()) <= 0) continue;
+    for (size_t i = 0; i < fds.size(); i++) {
+      if (fds[i].revents == 0) continue;
+      Source& source = *polled[i];
+      bool alive = source.connecting ? Subscribe(source) : Receive(source);
+      if (!alive) Disconnect(source);
+    }
+  }
+}
+
+// DONE: Return every agent with its latest snapshot
+vector<Aggregator::Source> const& Aggregator::Sources() const {
+  return sources_;
+}
+
+// DONE: Return the n processes using the most CPU across connected agents
+// Each agent ranks its own processes, so this is a k-way merge over the
+// heads of those rankings, costing O(n log k) for k agents.
+vector<Aggregator::HostProcess> Aggregator::Top(int n) const {
+  // (source, position in its ranking)
+  using Head = std::pair<size_t, size_t>;
+  auto lower = [this](Head const& a, Head const& b) {
+    return sources_[a.first].snapshot.processes[a.second].cpu <
+           sources_[b.first].snapshot.processes[b.second].cpu;
+  };
+  std::priority_queue<Head, vector<Head>, decltype(lower)> heads(lower);
+  for (size_t i = 0; i < sources_.size(); i++) {
+    if (sources_[i].Connected() && !sources_[i].snapshot.processes.empty())
+      heads.push({i, 0});
+  }
+
+  vector<HostProcess> top;
+  while (static_cast<int>(top.size()) < n && !heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    Source const& source = sources_[head.first];
+    Protocol::ProcessRecord const& process =
+        source.snapshot.processes[head.second];
+    top.push_back({source.snapshot.host.name, process,
+                   source.snapshot.host.uptime - process.start});
+    if (head.second + 1 < source.snapshot.processes.size())
+      heads.push({head.first, head.second + 1});
+  }
+  return top;
+}
+
+// DONE: Start connecting to an agent without waiting for it
+// The address is resolved on the first attempt and again after every
+// endpoint has failed, so name lookups are made only as often as retries.
+void Aggregator::Connect(Source& source) {
+  if (source.endpoints.empty()) {
+    source.endpoints = Protocol::Resolve(source.address);
+    source.next_endpoint = 0;
+  }
+  if (source.endpoints.empty()) {
+    Disconnect(source);
+    return;
+  }
+  source.fd = Protocol::Connect(source.endpoints[source.next_endpoint]);
+  if (source.fd < 0) {
+    Disconnect(source);
+    return;
+  }
+  source.connecting = true;
+  source.timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+}
+
+// DONE: Finish connecting and subscribe, returning false if either failed
+bool Aggregator::Subscribe(Source& source) {
+  int error{0};
+  socklen_t length = sizeof(error);
+  if (getsockopt(source.fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 ||
+      error != 0)
+    return false;
+  string frame = Protocol::EncodeSubscribe(top_);
+  if (send(source.fd, frame.data(), frame.size(), MSG_NOSIGNAL) !=
+      static_cast<ssize_t>(frame.size()))
+    return false;
+  source.connecting = false;
+  source.failures = 0;
+  return true;
+}
+
+// DONE: Apply the updates an agent has sent, returning false once it has gone
+bool Aggregator::Receive(Source& source) {
+  char buffer[16384];
+  ssize_t count = recv(source.fd, buffer, sizeof(buffer), 0);
+  if (count == 0) return false;
+  if (count < 0) return errno == EAGAIN || errno == EINTR;
+  source.received.append(buffer, count);
+
+  Protocol::FrameType type;
+  string payload;
+  Protocol::FrameStatus status;
+  while ((status = Protocol::NextFrame(source.received, type, payload)) ==
+         Protocol::kFrameComplete_) {
+    if (type == Protocol::kSubscribe_ ||
+        !Protocol::ApplyUpdate(payload, type == Protocol::kSnapshot_,
+                               source.snapshot))
+      return false;
+  }
+  return status != Protocol::kFrameMalformed_;
+}
+
+// DONE: Close the connection to an agent, keeping its last snapshot
+// The next attempt waits 1s, doubling with every consecutive failure up to
+// 32s, and moves on to the agent's next endpoint.
+void Aggregator::Disconnect(Source& source) {
+  if (source.fd >= 0) close(source.fd);
+  source.fd = -1;
+  source.connecting = false;
+  source.received.clear();
+
+  int backoff = 1 << std::min(source.failures, 5);
+  source.failures++;
+  source.retry =
+      std::chrono::steady_clock::now() + std::chrono::seconds(backoff);
+  if (!source.endpoints.empty() &&
+      ++source.next_endpoint >= source.endpoints.size())
+    source.endpoints.clear();
+}
@@ -1,9 +1,12 @@
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <iomanip>
 #include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "linux_parser.h"
@@ -13,13 +16,56 @@ using std::string;
 using std::to_string;
 using std::vector;
 
+namespace {
+string proc_directory{"/proc/"};
+
+// Files read through ReadCached, with their content as of the tick it was
+// last read in
+struct CachedFile {
+  int fd{-1};
+  unsigned long tick{0};
+  string content;
+};
+std::unordered_map<string, CachedFile> cached_files;
+unsigned long tick{1};
+
+// The subdirectories of a directory whose names are numbers, such as the
+// PIDs in /proc or the thread IDs in /proc/<pid>/task
+vector<int> NumberedDirectories(string const& path) {
+  vector<int> numbers;
+  DIR* directory = opendir(path.c_str());
+  if (directory == nullptr) return numbers;
+  struct dirent* file;
+  while ((file = readdir(directory)) != nullptr) {
+    // Is this a directory?
+    if (file->d_type == DT_DIR) {
+      // Is every character of the name a digit?
+      string filename(file->d_name);
+      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
+        numbers.push_back(stoi(filename));
+      }
+    }
+  }
+  closedir(directory);
+  return numbers;
+}
+}  // namespace
+
+// DONE: Return the procfs root
+string const& LinuxParser::ProcDirectory() { return proc_directory; }
+
+// DONE: Change the procfs root, before anything has been read from it
+void LinuxParser::SetProcDirectory(string const& path) {
+  proc_directory = path.empty() || path.back() == '/' ? path : path + '/';
+}
+
 // DONE: An example of how to read data from the filesystem
 string LinuxParser::OperatingSystem() {
   string line;
   string key;
   string value;
-  std::ifstream filestream(kOSPath);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(kOSPath, filestream)) {
     while (std::getline(filestream, line)) {
       std::replace(line.begin(), line.end(), ' ', '_');
       std::replace(line.begin(), line.end(), '=', ' ');
@@ -40,8 +86,8 @@ string LinuxParser::OperatingSystem() {
 string LinuxParser::Kernel() {
   string os, kernel, version;
   string line;
-  std::ifstream stream(kProcDirectory + kVersionFilename);
-  if (stream.is_open()) {
+  std::istringstream stream;
+  if (ReadCached(ProcDirectory() + kVersionFilename, stream)) {
     std::getline(stream, line);
     std::istringstream linestream(line);
     linestream >> os >> version >> kernel;
@@ -50,23 +96,46 @@ string LinuxParser::Kernel() {
 }
 
 // DONE: Update this to use std::filesystem
-vector<int> LinuxParser::Pids() {
-  vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
-  struct dirent* file;
-  while ((file = readdir(directory)) != nullptr) {
-    // Is this a directory?
-    if (file->d_type == DT_DIR) {
-      // Is every character of the name a digit?
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
-      }
+vector<int> LinuxParser::Pids() { return NumberedDirectories(ProcDirectory()); }
+
+// DONE: Return the thread IDs of a process, empty once it has exited
+vector<int> LinuxParser::Tasks(int pid) {
+  return NumberedDirectories(ProcDirectory() + '/' + to_string(pid) +
+                             kTaskDirectory);
+}
+
+// DONE: Start a new tick, after which ReadCached reads each file afresh
+void LinuxParser::NextTick() { tick++; }
+
+// DONE: Read a file that is polled every tick through a descriptor kept open
+// for the life of the process. procfs regenerates the content on every read
+// from offset 0, so the file is read at most once per tick and every caller
+// in that tick parses the same content.
+bool LinuxParser::ReadCached(string const& path, std::istringstream& stream) {
+  auto it = cached_files.find(path);
+  if (it == cached_files.end()) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    it = cached_files.emplace(path, CachedFile{fd, 0, string()}).first;
+  }
+
+  CachedFile& file = it->second;
+  if (file.tick != tick) {
+    string content;
+    char buffer[4096];
+    off_t offset = 0;
+    ssize_t count;
+    while ((count = pread(file.fd, buffer, sizeof(buffer), offset)) > 0) {
+      content.append(buffer, count);
+      offset += count;
     }
+    file.content = count < 0 ? string() : content;
+    file.tick = tick;
   }
-  closedir(directory);
-  return pids;
+  if (file.content.empty()) return false;
+  stream.clear();
+  stream.str(file.content);
+  return true;
 }
 
 // DONE: Read and return the system memory utilization
@@ -75,8 +144,8 @@ float LinuxParser::MemoryUtilization() {
   string key;
   string memTotal;
   string memFree;
-  std::ifstream filestream(kProcDirectory + kMeminfoFilename);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kMeminfoFilename, filestream)) {
     std::getline(filestream, line);
     std::istringstream linestream1(line);
     linestream1 >> key >> memTotal;
@@ -94,8 +163,8 @@ float LinuxParser::MemoryUtilization() {
 long LinuxParser::UpTime() {
   std::string line;
   std::string uptime;
-  std::ifstream filestream(kProcDirectory + kUptimeFilename);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kUptimeFilename, filestream)) {
     std::getline(filestream, line);
     std::istringstream linestream(line);
     linestream >> uptime;
@@ -116,7 +185,7 @@ long LinuxParser::Jiffies() {
 long LinuxParser::ActiveJiffies(int pid) {
   string line;
   string active_jiffies;
-  std::ifstream filestream(kProcDirectory + '/' + to_string(pid) +
+  std::ifstream filestream(ProcDirectory() + '/' + to_string(pid) +
                            kStatFilename);
   if (filestream.is_open()) {
     std::getline(filestream, line);
@@ -134,8 +203,8 @@ long LinuxParser::ActiveJiffies(int pid) {
 long LinuxParser::ActiveJiffies() {
   string line;
   string cpu, user, nice, system, idle, iowait, irq, softirq, steal;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kStatFilename, filestream)) {
     std::getline(filestream, line);
     std::istringstream linestream(line);
     linestream >> cpu >> user >> nice >> system >> idle >> iowait >> irq >>
@@ -151,8 +220,8 @@ long LinuxParser::ActiveJiffies() {
 long LinuxParser::IdleJiffies() {
   string line;
   string cpu, user, nice, system, idle, iowait;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kStatFilename, filestream)) {
     std::getline(filestream, line);
     std::istringstream linestream(line);
     linestream >> cpu >> user >> nice >> system >> idle >> iowait;
@@ -166,8 +235,8 @@ vector<string> LinuxParser::CpuUtilization() {
   string line;
   string cpu, user, nice, system, idle, iowait, irq, softirq, steal, guest,
       guest_nice;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kStatFilename, filestream)) {
     std::getline(filestream, line);
     std::istringstream linestream(line);
     linestream >> cpu >> user >> nice >> system >> idle >> iowait >> irq >>
@@ -181,9 +250,8 @@ vector<string> LinuxParser::CpuUtilization() {
 // DONE: Read and return the total number of processes
 int LinuxParser::TotalProcesses() {
   string line, key, value;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kStatFilename, filestream)) {
     while (std::getline(filestream, line) && key != "processes") {
       std::istringstream linestream(line);
       linestream >> key >> value;
@@ -196,8 +264,8 @@ int LinuxParser::TotalProcesses() {
 // DONE: Read and return the number of running processes
 int LinuxParser::RunningProcesses() {
   string line, key, value;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kStatFilename, filestream)) {
     while (std::getline(filestream, line) && key != "procs_running") {
       std::istringstream linestream(line);
       linestream >> key >> value;
@@ -207,53 +275,212 @@ int LinuxParser::RunningProcesses() {
   return 0;
 }
 
+// DONE: Read the ctxt, intr and procs_blocked lines of /proc/stat in one pass
+LinuxParser::StatCounters LinuxParser::Counters() {
+  StatCounters counters;
+  string line;
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kStatFilename, filestream)) {
+    while (std::getline(filestream, line)) {
+      string key, value;
+      std::istringstream linestream(line);
+      linestream >> key >> value;
+      if (key == "ctxt") {
+        counters.context_switches = std::stol(value);
+      } else if (key == "intr") {
+        counters.interrupts = std::stol(value);
+      } else if (key == "procs_blocked") {
+        counters.blocked_processes = std::stoi(value);
+      }
+    }
+  }
+  return counters;
+}
+
+// DONE: Read and return the 1, 5 and 15 minute load averages
+vector<float> LinuxParser::LoadAverages() {
+  float one{0}, five{0}, fifteen{0};
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kLoadavgFilename, filestream)) {
+    filestream >> one >> five >> fifteen;
+  }
+  return {one, five, fifteen};
+}
+
+// DONE: Read the Pressure Stall Information of a resource (cpu, memory, io)
+LinuxParser::Pressure LinuxParser::PressureStall(string const& resource) {
+  Pressure pressure;
+  string line;
+  std::istringstream filestream;
+  if (ReadCached(ProcDirectory() + kPressureDirectory + resource, filestream)) {
+    pressure.available = true;
+    while (std::getline(filestream, line)) {
+      string kind, key;
+      PressureLine values;
+      std::replace(line.begin(), line.end(), '=', ' ');
+      std::istringstream linestream(line);
+      linestream >> kind >> key >> values.avg10 >> key >> values.avg60 >>
+          key >> values.avg300 >> key >> values.total;
+      if (kind == "some") {
+        pressure.some = values;
+      } else if (kind == "full") {
+        pressure.full = values;
+      }
+    }
+  }
+  return pressure;
+}
+
+// DONE: Read the fields of /proc/<pid>/stat used to rank and filter processes
+LinuxParser::ProcessStat LinuxParser::Stat(int pid) {
+  ProcessStat stat;
+  string line;
+  std::ifstream filestream(ProcDirectory() + '/' + to_string(pid) +
+                           kStatFilename);
+  if (filestream.is_open() && std::getline(filestream, line)) {
+    // comm is parenthesised and may itself contain spaces or parentheses
+    size_t comm_start = line.find('(');
+    size_t comm_end = line.rfind(')');
+    if (comm_start == string::npos || comm_end == string::npos) return stat;
+    stat.pid = pid;
+    stat.comm = line.substr(comm_start + 1, comm_end - comm_start - 1);
+
+    // Fields from state (field 3) onwards
+    std::istringstream linestream(line.substr(comm_end + 1));
+    string value;
+    for (int i = 3; i <= 23 && linestream >> value; i++) {
+      if (i == 14)
+        stat.utime = std::stol(value);
+      else if (i == 15)
+        stat.stime = std::stol(value);
+      else if (i == 16)
+        stat.cutime = std::stol(value);
+      else if (i == 17)
+        stat.cstime = std::stol(value);
+      else if (i == 22)
+        stat.starttime = std::stol(value);
+      else if (i == 23)
+        stat.vsize = std::stol(value);
+    }
+    stat.available = true;
+  }
+  return stat;
+}
+
+// DONE: Return the user ID owning /proc/<pid> without reading any file
+// procfs gives the directory the effective user ID of a dumpable process
+// but root for a non-dumpable one: setuid programs, processes that changed
+// credentials and anything that called prctl(PR_SET_DUMPABLE, 0). A non-root
+// owner is therefore the process's user; root means it has to be read from
+// /proc/<pid>/status.
+string LinuxParser::OwnerUid(int pid) {
+  struct stat info;
+  if (::stat((ProcDirectory() + '/' + to_string(pid)).c_str(), &info) == 0) {
+    return to_string(info.st_uid);
+  }
+  return string();
+}
+
 // DONE: Read and return the command associated with a process
 string LinuxParser::Command(int pid) {
   string line;
-  std::ifstream filestream(kProcDirectory + '/' + to_string(pid) +
+  std::ifstream filestream(ProcDirectory() + '/' + to_string(pid) +
                            kCmdlineFilename);
   if (filestream.is_open()) {
     std::getline(filestream, line);
+    // Arguments are NUL separated, with a trailing NUL
+    std::replace(line.begin(), line.end(), '\0', ' ');
+    while (!line.empty() && line.back() == ' ') line.pop_back();
     return line;
   }
   return string();
 }
 
-// DONE: Read and return the memory used by a process
-// TODO: Limited precision here - character width might have been more sensible.
-string LinuxParser::Ram(int pid) {
-  string line, key, value;
-  std::ifstream filestream(kProcDirectory + '/' + to_string(pid) +
+// DONE: Read the status fields of a process in one pass over the file
+LinuxParser::ProcessStatus LinuxParser::Status(int pid) {
+  ProcessStatus status;
+  string line;
+  std::ifstream filestream(ProcDirectory() + '/' + to_string(pid) +
                            kStatusFilename);
   if (filestream.is_open()) {
-    while (std::getline(filestream, line) && key != "VmSize:") {
+    while (std::getline(filestream, line)) {
+      string key, value;
       std::istringstream linestream(line);
       linestream >> key >> value;
+      if (key == "Uid:") {
+        status.uid = value;
+      } else if (key == "VmSize:") {
+        std::stringstream stream;
+        stream << std::fixed << std::setprecision(1) << stof(value) / 1024;
+        status.ram = stream.str();
+      }
     };
-    std::stringstream stream;
-    stream << std::fixed << std::setprecision(1) << stof(value) / 1024;
-    return stream.str();
   }
-  return string();
+  return status;
+}
+
+// DONE: Sum the scheduler statistics and context switches of every thread
+// Costs two reads per thread. Threads that have exited are no longer
+// counted, and schedstat is zero if the kernel was built without schedstats.
+LinuxParser::SchedulerCounters LinuxParser::Scheduler(int pid) {
+  SchedulerCounters counters;
+  string task_directory =
+      ProcDirectory() + '/' + to_string(pid) + kTaskDirectory;
+  for (int tid : Tasks(pid)) {
+    string directory = task_directory + to_string(tid);
+    std::ifstream schedstat(directory + kSchedstatFilename);
+    long run_time{0}, wait_time{0}, timeslices{0};
+    if (schedstat >> run_time >> wait_time >> timeslices) {
+      counters.schedstat[kRunTime_] += run_time;
+      counters.schedstat[kWaitTime_] += wait_time;
+      counters.schedstat[kTimeslices_] += timeslices;
+    }
+
+    string line;
+    std::ifstream status(directory + kStatusFilename);
+    while (std::getline(status, line)) {
+      string key, value;
+      std::istringstream linestream(line);
+      linestream >> key >> value;
+      if (key == "voluntary_ctxt_switches:") {
+        counters.voluntary_ctxt_switches += std::stol(value);
+      } else if (key == "nonvoluntary_ctxt_switches:") {
+        counters.nonvoluntary_ctxt_switches += std::stol(value);
+      }
+    }
+  }
+  return counters;
 }
 
+// DONE: Read and return the memory used by a process
+// TODO: Limited precision here - character width might have been more sensible.
+string LinuxParser::Ram(int pid) { return Status(pid).ram; }
+
 // DONE: Read and return the user ID associated with a process
-string LinuxParser::Uid(int pid) {
-  string line, key, value;
-  std::ifstream filestream(kProcDirectory + '/' + to_string(pid) +
-                           kStatusFilename);
+string LinuxParser::Uid(int pid) { return Status(pid).uid; }
+
+// DONE: Read and return the user associated with a process
+string LinuxParser::User(int pid) { return UserName(Uid(pid)); }
+
+// DONE: Read and return the user name associated with a user ID
+string LinuxParser::UserName(string const& uid) {
+  string line, username, password, id;
+  std::ifstream filestream(kPasswordPath);
   if (filestream.is_open()) {
-    while (std::getline(filestream, line) && key != "Uid:") {
+    while (std::getline(filestream, line)) {
+      std::replace(line.begin(), line.end(), ':', ' ');
       std::istringstream linestream(line);
-      linestream >> key >> value;
+      linestream >> username >> password >> id;
+      if (id == uid) {
+        return username;
+      };
     };
-    return value;
   }
   return string();
 }
 
-// DONE: Read and return the user associated with a process
-string LinuxParser::User(int pid) {
+// DONE: Read and return the user ID associated with a user name
+string LinuxParser::UserId(string const& name) {
   string line, username, password, uid;
   std::ifstream filestream(kPasswordPath);
   if (filestream.is_open()) {
@@ -261,8 +488,8 @@ string LinuxParser::User(int pid) {
       std::replace(line.begin(), line.end(), ':', ' ');
       std::istringstream linestream(line);
       linestream >> username >> password >> uid;
-      if (uid == Uid(pid)) {
-        return username;
+      if (username == name) {
+        return uid;
       };
     };
   }
@@ -274,11 +501,12 @@ string LinuxParser::User(int pid) {
 // LinuxParser::ProcessUtilisation.
 long LinuxParser::UpTime(int pid_) {
   string value;
-  long starttime;
-  std::ifstream filestream(kProcDirectory + '/' + to_string(pid_) +
+  long starttime{0};
+  std::ifstream filestream(ProcDirectory() + '/' + to_string(pid_) +
                            kStatFilename);
   if (filestream.is_open()) {
     for (int i = 1; i <= 22; i++) filestream >> value;
+    if (!filestream) return 0;
     starttime = std::stol(value);
     filestream.close();
   }
@@ -291,37 +519,19 @@ long LinuxParser::UpTime(int pid_) {
 // TODO: Could refactor any functionality shared with LinuxParser::UpTime(int
 // pid_).
 float LinuxParser::ProcessUtilization(int pid) {
+  return ProcessUtilization(Stat(pid));
+}
+
+// DONE: Return the CPU utilization over the lifetime of a process
+float LinuxParser::ProcessUtilization(ProcessStat const& stat) {
   // Based on:
   // https://stackoverflow.com/questions/16726779/how-do-i-get-the-total-cpu-usage-of-an-application-from-proc-pid-stat/16736599#16736599
 
-  float userTime, kernelTime, wfcUserTime, wfcKernelTime, startTime, totalTime,
-      elapsedTime;
-  string line, key, value;
-
-  std::ifstream filestream(kProcDirectory + '/' + to_string(pid) +
-                           kStatFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-
-      for (int i = 0; i <= 21; i++) {
-        linestream >> value;
-        if (i == 13)
-          userTime = stof(value);
-        else if (i == 14)
-          kernelTime = stof(value);
-        else if (i == 15)
-          wfcUserTime = stof(value);
-        else if (i == 16)
-          wfcKernelTime = stof(value);
-        else if (i == 21)
-          startTime = stof(value);
-      }
-    }
-
-    totalTime = (userTime + kernelTime + wfcUserTime + wfcKernelTime) /
-                sysconf(_SC_CLK_TCK);
-    elapsedTime = LinuxParser::UpTime() - startTime / sysconf(_SC_CLK_TCK);
-  }
+  float totalTime = static_cast<float>(stat.utime + stat.stime + stat.cutime +
+                                       stat.cstime) /
+                    sysconf(_SC_CLK_TCK);
+  float elapsedTime = LinuxParser::UpTime() -
+                      static_cast<float>(stat.starttime) / sysconf(_SC_CLK_TCK);
+  if (elapsedTime <= 0) return 0.0;
   return totalTime / elapsedTime;
-}
\ No newline at end of file
+}
@@ -1,7 +1,55 @@
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "agent.h"
+#include "aggregator.h"
+#include "linux_parser.h"
 #include "ncurses_display.h"
 #include "system.h"
 
-int main() {
+// Usage:
+//   monitor [--proc DIR]
+//   monitor --agent ADDRESS [--name NAME] [--proc DIR]
+//   monitor --aggregate ADDRESS...
+// ADDRESS is unix:<path> or <host>:<port>, see include/protocol.h.
+int main(int argc, char* argv[]) {
+  std::string agent, name;
+  std::vector<std::string> agents;
+  for (int i = 1; i < argc; i++) {
+    std::string argument{argv[i]};
+    if (argument == "--proc" && i + 1 < argc) {
+      LinuxParser::SetProcDirectory(argv[++i]);
+    } else if (argument == "--agent" && i + 1 < argc) {
+      agent = argv[++i];
+    } else if (argument == "--name" && i + 1 < argc) {
+      name = argv[++i];
+    } else if (argument == "--aggregate") {
+      while (i + 1 < argc && argv[i + 1][0] != '-') agents.push_back(argv[++i]);
+    } else {
+      std::cerr << "monitor: unknown argument " << argument << "\n";
+      return 1;
+    }
+  }
+
   System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+  if (!agent.empty()) {
+    if (name.empty()) {
+      char hostname[256]{};
+      gethostname(hostname, sizeof(hostname) - 1);
+      name = hostname;
+    }
+    Agent server(system, name);
+    if (!server.Listen(agent)) {
+      std::cerr << "monitor: cannot listen on " << agent << "\n";
+      return 1;
+    }
+    server.Run();
+  } else if (!agents.empty()) {
+    Aggregator aggregator(agents, 10);
+    NCursesDisplay::Display(aggregator);
+  } else {
+    NCursesDisplay::Display(system);
+  }
+}
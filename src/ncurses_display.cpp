@@ -1,10 +1,14 @@
 #include <curses.h>
+#include <algorithm>
 #include <chrono>
+#include <regex>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "format.h"
+#include "linux_parser.h"
 #include "ncurses_display.h"
 #include "system.h"
 
@@ -52,21 +56,113 @@ void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
   wrefresh(window);
 }
 
+// Load averages, blocked processes, context switch and interrupt rates, and
+// Pressure Stall Information as percentages: the kernel's 10/60/300 second
+// averages and the share of the last tick spent stalled.
+void NCursesDisplay::DisplayLoad(System& system, WINDOW* window) {
+  Saturation& load = system.Load();
+  load.Update();
+
+  int row{0};
+  int const load_column{2};
+  int const blocked_column{25};
+  int const context_switch_column{40};
+  int const interrupt_column{58};
+  std::vector<float> averages = load.LoadAverages();
+  mvwprintw(window, ++row, load_column,
+            (string(window->_maxx - 2, ' ').c_str()));
+  mvwprintw(window, row, load_column,
+            ("Load: " + to_string(averages[0]).substr(0, 4) + " " +
+             to_string(averages[1]).substr(0, 4) + " " +
+             to_string(averages[2]).substr(0, 4))
+                .c_str());
+  mvwprintw(window, row, blocked_column,
+            ("Blocked: " + to_string(load.BlockedProcesses())).c_str());
+  mvwprintw(window, row, context_switch_column,
+            ("Ctxt/s: " +
+             to_string(static_cast<long>(load.ContextSwitchRate())))
+                .c_str());
+  mvwprintw(window, row, interrupt_column,
+            ("Intr/s: " + to_string(static_cast<long>(load.InterruptRate())))
+                .c_str());
+
+  int const name_column{2};
+  int const some_column{10};
+  int const full_column{44};
+  std::vector<int> const some_columns{16, 23, 30, 38};
+  std::vector<int> const full_columns{50, 57, 64, 72};
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, name_column, "PSI[%%]");
+  mvwprintw(window, row, some_column, "some:");
+  mvwprintw(window, row, full_column, "full:");
+  std::vector<string> const headers{"avg10", "avg60", "avg300", "tick"};
+  for (size_t i = 0; i < headers.size(); ++i) {
+    mvwprintw(window, row, some_columns[i], headers[i].c_str());
+    mvwprintw(window, row, full_columns[i], headers[i].c_str());
+  }
+  wattroff(window, COLOR_PAIR(2));
+
+  std::vector<string> const names{"CPU", "Memory", "IO"};
+  for (int i = 0; i < 3; ++i) {
+    auto resource = static_cast<Saturation::PressureResource>(i);
+    LinuxParser::Pressure const& stall = load.Stall(resource);
+    mvwprintw(window, ++row, name_column,
+              (string(window->_maxx - 2, ' ').c_str()));
+    mvwprintw(window, row, name_column, names[i].c_str());
+    if (!stall.available) {
+      mvwprintw(window, row, some_columns[0], "n/a");
+      continue;
+    }
+    std::vector<float> const some{stall.some.avg10, stall.some.avg60,
+                                  stall.some.avg300,
+                                  load.SomeStallRate(resource) * 100};
+    std::vector<float> const full{stall.full.avg10, stall.full.avg60,
+                                  stall.full.avg300,
+                                  load.FullStallRate(resource) * 100};
+    for (size_t j = 0; j < some.size(); ++j) {
+      mvwprintw(window, row, some_columns[j],
+                to_string(some[j]).substr(0, 5).c_str());
+      mvwprintw(window, row, full_columns[j],
+                to_string(full[j]).substr(0, 5).c_str());
+    }
+  }
+  wrefresh(window);
+}
+
+// Scheduler columns show per-interval deltas: run and run-queue wait time in
+// ms, timeslices, and voluntary/involuntary context switches. They take the
+// place of RAM and TIME+ so that COMMAND still fits in 80 columns.
 void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+                                      WINDOW* window, int n,
+                                      bool scheduler_columns) {
   int row{0};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
   int const ram_column{26};
   int const time_column{35};
-  int const command_column{46};
+  int const run_column{26};
+  int const wait_column{34};
+  int const slices_column{43};
+  int const vcsw_column{50};
+  int const nvcsw_column{57};
+  int const command_column{scheduler_columns ? 64 : 46};
   wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
+  mvwprintw(window, ++row, pid_column,
+            (string(window->_maxx - 2, ' ').c_str()));
+  mvwprintw(window, row, pid_column, "PID");
   mvwprintw(window, row, user_column, "USER");
   mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
+  if (scheduler_columns) {
+    mvwprintw(window, row, run_column, "RUN[ms]");
+    mvwprintw(window, row, wait_column, "WAIT[ms]");
+    mvwprintw(window, row, slices_column, "SLICES");
+    mvwprintw(window, row, vcsw_column, "VCSW");
+    mvwprintw(window, row, nvcsw_column, "NVCSW");
+  } else {
+    mvwprintw(window, row, ram_column, "RAM[MB]");
+    mvwprintw(window, row, time_column, "TIME+");
+  }
   mvwprintw(window, row, command_column, "COMMAND");
   wattroff(window, COLOR_PAIR(2));
   for (int i = 0; i < n; ++i) {
@@ -75,41 +171,278 @@ void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
     // Clear the line
     mvwprintw(window, ++row, pid_column,
               (string(window->_maxx - 2, ' ').c_str()));
+    // A filter can leave fewer processes than rows
+    if (i >= static_cast<int>(processes.size())) continue;
 
     mvwprintw(window, row, pid_column, to_string(processes[i].Pid()).c_str());
     mvwprintw(window, row, user_column, processes[i].User().c_str());
     float cpu = processes[i].CpuUtilization() * 100;
     mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
+    if (scheduler_columns) {
+      mvwprintw(window, row, run_column,
+                to_string(processes[i].RunTime() / 1000000).c_str());
+      mvwprintw(window, row, wait_column,
+                to_string(processes[i].WaitTime() / 1000000).c_str());
+      mvwprintw(window, row, slices_column,
+                to_string(processes[i].Timeslices()).c_str());
+      mvwprintw(window, row, vcsw_column,
+                to_string(processes[i].VoluntarySwitches()).c_str());
+      mvwprintw(window, row, nvcsw_column,
+                to_string(processes[i].NonvoluntarySwitches()).c_str());
+    } else {
+      mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
+      mvwprintw(window, row, time_column,
+                Format::ElapsedTime(processes[i].UpTime()).c_str());
+    }
     mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
+              processes[i]
+                  .Command()
+                  .substr(0, window->_maxx - command_column)
+                  .c_str());
   }
 }
 
+// The active filter, on the last line of a window such as stdscr
+void NCursesDisplay::DisplayFilter(ProcessFilter const& filter,
+                                   WINDOW* window) {
+  wmove(window, getmaxy(window) - 1, 0);
+  wclrtoeol(window);
+  wprintw(window, "Filter: %s", filter.Description().c_str());
+}
+
+// Change one filter criterion from the key pressed; an empty answer clears
+// it. Invalid numbers clear the threshold and invalid regexes are ignored.
+void NCursesDisplay::EditFilter(ProcessFilter& filter, WINDOW* window,
+                                int key) {
+  switch (key) {
+    case 'u':
+      filter.User(Prompt(window, "User: "));
+      break;
+    case '/':
+      filter.Name(Prompt(window, "Name contains: "));
+      break;
+    case 'r':
+      try {
+        filter.NameRegex(Prompt(window, "Name regex: "));
+      } catch (std::regex_error const&) {
+      }
+      break;
+    case 'a':
+      filter.CommandLine(Prompt(window, "Command line contains: "));
+      break;
+    case 'p': {
+      string answer = Prompt(window, "PIDs: ");
+      std::replace(answer.begin(), answer.end(), ',', ' ');
+      std::istringstream stream(answer);
+      std::vector<int> pids;
+      int pid;
+      while (stream >> pid) pids.push_back(pid);
+      filter.Pids(pids);
+      break;
+    }
+    case 'c': {
+      float percent{0};
+      std::istringstream(Prompt(window, "Minimum CPU[%]: ")) >> percent;
+      filter.MinCpuUtilization(percent);
+      break;
+    }
+    case 'm': {
+      float megabytes{0};
+      std::istringstream(Prompt(window, "Minimum RAM[MB]: ")) >> megabytes;
+      filter.MinRam(megabytes);
+      break;
+    }
+    case 'x':
+      filter.Clear();
+      break;
+  }
+}
+
+// Read a line of input on the last line of a window, waiting for it however
+// long the window's refresh timeout is
+string NCursesDisplay::Prompt(WINDOW* window, string const& label) {
+  char answer[256]{};
+  int delay = wgetdelay(window);
+  wmove(window, getmaxy(window) - 1, 0);
+  wclrtoeol(window);
+  wprintw(window, "%s", label.c_str());
+  echo();
+  wtimeout(window, -1);
+  wgetnstr(window, answer, sizeof(answer) - 1);
+  wtimeout(window, delay);
+  noecho();
+  return answer;
+}
+
+// Keys: 's' toggles the scheduler columns, 'o' switches the process table
+// between CPU and run-queue wait ordering, 'q' quits.
+// Filters: 'u' user, '/' name substring, 'r' name regex, 'a' command line
+// substring, 'p' PID list, 'c' minimum CPU, 'm' minimum RAM, 'x' clears them
+// all. Names are the 15-character comm field; only 'a' reads the command line.
 void NCursesDisplay::Display(System& system, int n) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
+  timeout(1000);  // refresh at least once a second while waiting for keys
+
+  bool scheduler_columns{false};
 
   int x_max{getmaxx(stdscr)};
   WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
+  WINDOW* load_window = newwin(7, x_max - 1, system_window->_maxy + 1, 0);
+  // Show fewer processes rather than run off a short terminal, keeping the
+  // last line for the filter
+  n = std::max(1, std::min(n, LINES - 9 - 7 - 3 - 1));
   WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
+      newwin(3 + n, x_max - 1,
+             system_window->_maxy + 1 + load_window->_maxy + 1, 0);
 
-  while (1) {
+  bool running{true};
+  while (running) {
+    LinuxParser::NextTick();
     init_pair(1, COLOR_BLUE, COLOR_BLACK);
     init_pair(2, COLOR_GREEN, COLOR_BLACK);
     box(system_window, 0, 0);
+    box(load_window, 0, 0);
     box(process_window, 0, 0);
     DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
+    DisplayLoad(system, load_window);
+    DisplayProcesses(system.Processes(), process_window, n,
+                     scheduler_columns);
+    DisplayFilter(system.Filter(), stdscr);
     wrefresh(system_window);
+    wrefresh(load_window);
+    wrefresh(process_window);
+    refresh();
+    int key = getch();
+    switch (key) {
+      case 's':
+        scheduler_columns = !scheduler_columns;
+        break;
+      case 'o':
+        system.SortBy(system.SortOrder() == System::kCpuSort_
+                          ? System::kWaitTimeSort_
+                          : System::kCpuSort_);
+        break;
+      case 'q':
+        running = false;
+        break;
+      default:
+        EditFilter(system.Filter(), stdscr, key);
+        break;
+    }
+  }
+  endwin();
+}
+
+// One row per agent, with its last snapshot while it is unreachable
+void NCursesDisplay::DisplayHosts(Aggregator const& aggregator,
+                                  WINDOW* window) {
+  int row{0};
+  int const host_column{2};
+  int const cpu_column{18};
+  int const memory_column{27};
+  int const total_column{36};
+  int const running_column{45};
+  int const time_column{54};
+  int const status_column{65};
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, host_column, "HOST");
+  mvwprintw(window, row, cpu_column, "CPU[%%]");
+  mvwprintw(window, row, memory_column, "MEM[%%]");
+  mvwprintw(window, row, total_column, "PROCS");
+  mvwprintw(window, row, running_column, "RUNNING");
+  mvwprintw(window, row, time_column, "UP TIME");
+  mvwprintw(window, row, status_column, "STATUS");
+  wattroff(window, COLOR_PAIR(2));
+  for (auto const& source : aggregator.Sources()) {
+    Protocol::HostRecord const& host = source.snapshot.host;
+    mvwprintw(window, ++row, host_column,
+              (string(window->_maxx - 2, ' ').c_str()));
+    string name = host.name.empty() ? source.address : host.name;
+    mvwprintw(window, row, host_column, "%s",
+              name.substr(0, cpu_column - host_column - 1).c_str());
+    mvwprintw(window, row, cpu_column,
+              to_string(host.cpu * 100).substr(0, 4).c_str());
+    mvwprintw(window, row, memory_column,
+              to_string(host.memory * 100).substr(0, 4).c_str());
+    mvwprintw(window, row, total_column,
+              to_string(host.total_processes).c_str());
+    mvwprintw(window, row, running_column,
+              to_string(host.running_processes).c_str());
+    mvwprintw(window, row, time_column,
+              Format::ElapsedTime(host.uptime).c_str());
+    mvwprintw(window, row, status_column,
+              source.Connected() ? "up" : "down");
+  }
+}
+
+void NCursesDisplay::DisplayHostProcesses(
+    std::vector<Aggregator::HostProcess> const& processes, WINDOW* window,
+    int n) {
+  int row{0};
+  int const host_column{2};
+  int const pid_column{18};
+  int const user_column{25};
+  int const cpu_column{32};
+  int const ram_column{42};
+  int const time_column{51};
+  int const command_column{62};
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, host_column, "HOST");
+  mvwprintw(window, row, pid_column, "PID");
+  mvwprintw(window, row, user_column, "USER");
+  mvwprintw(window, row, cpu_column, "CPU[%%]");
+  mvwprintw(window, row, ram_column, "RAM[MB]");
+  mvwprintw(window, row, time_column, "TIME+");
+  mvwprintw(window, row, command_column, "COMMAND");
+  wattroff(window, COLOR_PAIR(2));
+  for (int i = 0; i < n; ++i) {
+    mvwprintw(window, ++row, host_column,
+              (string(window->_maxx - 2, ' ').c_str()));
+    if (i >= static_cast<int>(processes.size())) continue;
+
+    Protocol::ProcessRecord const& process = processes[i].process;
+    string host = processes[i].host.substr(0, pid_column - host_column - 1);
+    mvwprintw(window, row, host_column, "%s", host.c_str());
+    mvwprintw(window, row, pid_column, to_string(process.pid).c_str());
+    mvwprintw(window, row, user_column, "%s", process.user.c_str());
+    mvwprintw(window, row, cpu_column,
+              to_string(process.cpu * 100).substr(0, 4).c_str());
+    mvwprintw(window, row, ram_column, "%.1f", process.ram);
+    mvwprintw(window, row, time_column,
+              Format::ElapsedTime(processes[i].uptime).c_str());
+    string command = process.command.substr(0, window->_maxx - command_column);
+    mvwprintw(window, row, command_column, "%s", command.c_str());
+  }
+}
+
+// Merged view of several agents; 'q' quits.
+void NCursesDisplay::Display(Aggregator& aggregator, int n) {
+  initscr();      // start ncurses
+  noecho();       // do not print input values
+  cbreak();       // terminate ncurses on ctrl + c
+  start_color();  // enable color
+  timeout(0);     // the wait for updates happens in Aggregator::Poll
+
+  int x_max{getmaxx(stdscr)};
+  int hosts = aggregator.Sources().size();
+  WINDOW* host_window = newwin(3 + hosts, x_max - 1, 0, 0);
+  WINDOW* process_window =
+      newwin(3 + n, x_max - 1, host_window->_maxy + 1, 0);
+
+  while (getch() != 'q') {
+    init_pair(1, COLOR_BLUE, COLOR_BLACK);
+    init_pair(2, COLOR_GREEN, COLOR_BLACK);
+    aggregator.Poll(1000);
+    box(host_window, 0, 0);
+    box(process_window, 0, 0);
+    DisplayHosts(aggregator, host_window);
+    DisplayHostProcesses(aggregator.Top(n), process_window, n);
+    wrefresh(host_window);
     wrefresh(process_window);
     refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
   }
   endwin();
 }
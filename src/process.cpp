@@ -1,4 +1,5 @@
 #include <unistd.h>
+#include <algorithm>
 #include <cctype>
 #include <sstream>
 #include <string>
@@ -11,26 +12,86 @@ using std::string;
 using std::to_string;
 using std::vector;
 
+// DONE: Sample this process once per tick
+// stat has already been read by System to decide whether to keep the
+// process. /proc/<pid>/status is read once here and shared by User and Ram;
+// the scheduler counters are summed over the threads of the process.
+// Counters are reported as the change since the previous Update, so the first
+// sample of a process reports zero. A thread exiting takes its counts out of
+// the sum, so a change is never reported below zero.
+void Process::Update(LinuxParser::ProcessStat const& stat) {
+  LinuxParser::ProcessStatus status = LinuxParser::Status(Process::Pid());
+  LinuxParser::SchedulerCounters counters =
+      LinuxParser::Scheduler(Process::Pid());
+
+  if (sampled_) {
+    for (size_t i = 0; i < counters.schedstat.size(); i++) {
+      schedstat_delta_[i] = std::max(0L, counters.schedstat[i] - schedstat_[i]);
+    }
+    voluntary_switches_delta_ =
+        std::max(0L, counters.voluntary_ctxt_switches - voluntary_switches_);
+    nonvoluntary_switches_delta_ = std::max(
+        0L, counters.nonvoluntary_ctxt_switches - nonvoluntary_switches_);
+  }
+
+  start_time_ = stat.starttime;
+  cpu_ = LinuxParser::ProcessUtilization(stat);
+  uid_ = status.uid;
+  ram_ = status.ram;
+  schedstat_ = counters.schedstat;
+  voluntary_switches_ = counters.voluntary_ctxt_switches;
+  nonvoluntary_switches_ = counters.nonvoluntary_ctxt_switches;
+  sampled_ = true;
+}
+
 // DONE: Return this process's ID
 int Process::Pid() const { return pid_; }
 
+// DONE: Return when this process started, in clock ticks after boot
+long Process::StartTime() const { return start_time_; }
+
 // DONE: Return this process's CPU utilization
 // Source of help: https://knowledge.udacity.com/questions/834579
-float Process::CpuUtilization() const {
-  return LinuxParser::ProcessUtilization(Process::Pid());
-}
+float Process::CpuUtilization() const { return cpu_; }
 
 // DONE: Return the command that generated this process
 string Process::Command() { return LinuxParser::Command(Process::Pid()); }
 
 // DONE: Return this process's memory utilization
-string Process::Ram() { return LinuxParser::Ram(Process::Pid()); }
+string Process::Ram() { return ram_; }
 
 // DONE: Return the user (name) that generated this process
-string Process::User() { return LinuxParser::User(Process::Pid()); }
+string Process::User() { return LinuxParser::UserName(uid_); }
 
 // DONE: Return the age of this process (in seconds)
-long int Process::UpTime() { return LinuxParser::UpTime(Process::Pid()); }
+// From the start time of the last Update, without reading stat again.
+long int Process::UpTime() {
+  return LinuxParser::UpTime() - start_time_ / sysconf(_SC_CLK_TCK);
+}
+
+// DONE: Return the time (ns) spent on a CPU over the last interval
+long Process::RunTime() const {
+  return schedstat_delta_[LinuxParser::kRunTime_];
+}
+
+// DONE: Return the time (ns) spent waiting on a run queue over the last
+// interval
+long Process::WaitTime() const {
+  return schedstat_delta_[LinuxParser::kWaitTime_];
+}
+
+// DONE: Return the number of timeslices run over the last interval
+long Process::Timeslices() const {
+  return schedstat_delta_[LinuxParser::kTimeslices_];
+}
+
+// DONE: Return the voluntary context switches over the last interval
+long Process::VoluntarySwitches() const { return voluntary_switches_delta_; }
+
+// DONE: Return the involuntary context switches over the last interval
+long Process::NonvoluntarySwitches() const {
+  return nonvoluntary_switches_delta_;
+}
 
 // DONE: Overload the "less than" comparison operator for Process objects
 // and rank by CPU utilization.
@@ -39,4 +100,4 @@ bool Process::operator<(Process const& a) const {
     return true;
   }
   return false;
-}
\ No newline at end of file
+}
@@ -0,0 +1,88 @@
+#include <regex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process_filter.h"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+// DONE: Keep only processes owned by a user, or clear with an empty name
+// An unknown user name matches no process.
+void ProcessFilter::User(string const& name) {
+  user_ = name;
+  uid_ = name.empty() ? string() : LinuxParser::UserId(name);
+}
+
+// DONE: Keep only processes whose name contains a substring
+void ProcessFilter::Name(string const& substring) { name_ = substring; }
+
+// DONE: Keep only processes whose name matches a regular expression
+void ProcessFilter::NameRegex(string const& pattern) {
+  regex_ = std::regex(pattern, std::regex::nosubs);
+  pattern_ = pattern;
+}
+
+// DONE: Keep only processes whose full command line contains a substring
+void ProcessFilter::CommandLine(string const& substring) {
+  command_line_ = substring;
+}
+
+// DONE: Keep only the given processes, or clear with an empty list
+void ProcessFilter::Pids(vector<int> const& pids) {
+  pids_ = std::unordered_set<int>(pids.begin(), pids.end());
+}
+
+// DONE: Keep only processes at or above a lifetime CPU utilization
+void ProcessFilter::MinCpuUtilization(float percent) { min_cpu_ = percent; }
+
+// DONE: Keep only processes at or above a virtual memory size
+void ProcessFilter::MinRam(float megabytes) { min_ram_ = megabytes; }
+
+// DONE: Remove every criterion
+void ProcessFilter::Clear() { *this = ProcessFilter(); }
+
+// DONE: Return a one line summary of the active criteria
+string ProcessFilter::Description() const {
+  string description;
+  if (!user_.empty()) description += " user=" + user_;
+  if (!name_.empty()) description += " name=" + name_;
+  if (!pattern_.empty()) description += " regex=" + pattern_;
+  if (!command_line_.empty()) description += " cmdline=" + command_line_;
+  if (!pids_.empty()) description += " pids=" + to_string(pids_.size());
+  if (min_cpu_ > 0) description += " cpu>=" + to_string(min_cpu_).substr(0, 4);
+  if (min_ram_ > 0) description += " ram>=" + to_string(min_ram_).substr(0, 6);
+  return description.empty() ? "none" : description.substr(1);
+}
+
+// DONE: Apply the criteria that need no file of the process to be read
+// The user is matched against the owner of /proc/<pid>, except for
+// processes procfs shows as root's, whose real user ID has to be read from
+// /proc/<pid>/status to agree with the USER column.
+bool ProcessFilter::Admits(int pid) const {
+  if (!pids_.empty() && pids_.find(pid) == pids_.end()) return false;
+  if (!user_.empty()) {
+    if (uid_.empty()) return false;
+    string owner = LinuxParser::OwnerUid(pid);
+    if (owner == "0") owner = LinuxParser::Uid(pid);
+    if (owner != uid_) return false;
+  }
+  return true;
+}
+
+// DONE: Apply the criteria that need /proc/<pid>/stat
+// The command line is read last, only once every other criterion has passed.
+bool ProcessFilter::Admits(LinuxParser::ProcessStat const& stat) const {
+  if (min_cpu_ > 0 && LinuxParser::ProcessUtilization(stat) * 100 < min_cpu_)
+    return false;
+  if (min_ram_ > 0 && stat.vsize / 1024.0 / 1024.0 < min_ram_) return false;
+  if (!name_.empty() && stat.comm.find(name_) == string::npos) return false;
+  if (!pattern_.empty() && !std::regex_search(stat.comm, regex_)) return false;
+  if (!command_line_.empty() &&
+      LinuxParser::Command(stat.pid).find(command_line_) == string::npos)
+    return false;
+  return true;
+}
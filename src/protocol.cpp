@@ -0,0 +1,329 @@
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "protocol.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+// Larger frames are treated as a corrupt stream
+const uint64_t kMaxFrameLength{1 << 24};
+
+uint64_t Quantize(float value, float scale) {
+  return value > 0 ? static_cast<uint64_t>(std::lround(value * scale)) : 0;
+}
+
+string EncodeProcess(Protocol::ProcessRecord const& process) {
+  string buffer;
+  Protocol::PutVarint(buffer, process.pid);
+  Protocol::PutVarint(buffer, Quantize(process.cpu, 1e4));
+  Protocol::PutVarint(buffer, Quantize(process.ram, 10));
+  Protocol::PutVarint(buffer, process.start > 0 ? process.start : 0);
+  Protocol::PutString(buffer, process.user);
+  Protocol::PutString(buffer, process.command);
+  return buffer;
+}
+
+bool DecodeProcess(string const& buffer, size_t& offset,
+                   Protocol::ProcessRecord& process) {
+  uint64_t pid, cpu, ram, start;
+  if (!Protocol::GetVarint(buffer, offset, pid) ||
+      !Protocol::GetVarint(buffer, offset, cpu) ||
+      !Protocol::GetVarint(buffer, offset, ram) ||
+      !Protocol::GetVarint(buffer, offset, start) ||
+      !Protocol::GetString(buffer, offset, process.user) ||
+      !Protocol::GetString(buffer, offset, process.command))
+    return false;
+  process.pid = pid;
+  process.cpu = cpu / 1e4;
+  process.ram = ram / 10.0;
+  process.start = start;
+  return true;
+}
+
+}  // namespace
+
+// DONE: Append an unsigned LEB128 varint
+void Protocol::PutVarint(string& buffer, uint64_t value) {
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+// DONE: Append a length-prefixed string
+void Protocol::PutString(string& buffer, string const& value) {
+  PutVarint(buffer, value.size());
+  buffer += value;
+}
+
+// DONE: Wrap a payload into a frame
+string Protocol::Frame(FrameType type, string const& payload) {
+  string buffer;
+  PutVarint(buffer, payload.size() + 1);
+  buffer.push_back(static_cast<char>(type));
+  return buffer + payload;
+}
+
+// DONE: Ask an agent for its top processes
+string Protocol::EncodeSubscribe(int top) {
+  string payload;
+  PutVarint(payload, top > 0 ? top : 0);
+  return Frame(kSubscribe_, payload);
+}
+
+// DONE: Encode the changes from previous to current
+// A full update ignores previous and carries every record.
+string Protocol::EncodeUpdate(Snapshot const& previous, Snapshot const& current,
+                              bool full) {
+  string payload;
+  PutString(payload, current.host.name);
+  PutVarint(payload, Quantize(current.host.cpu, 1e4));
+  PutVarint(payload, Quantize(current.host.memory, 1e4));
+  PutVarint(payload, current.host.total_processes);
+  PutVarint(payload, current.host.running_processes);
+  PutVarint(payload, current.host.uptime > 0 ? current.host.uptime : 0);
+
+  std::unordered_map<int, string> sent;
+  if (!full) {
+    for (auto const& process : previous.processes) {
+      sent[process.pid] = EncodeProcess(process);
+    }
+  }
+
+  string upserts;
+  int upsert_count{0};
+  for (auto const& process : current.processes) {
+    string record = EncodeProcess(process);
+    auto it = sent.find(process.pid);
+    if (it == sent.end() || it->second != record) {
+      upserts += record;
+      upsert_count++;
+    }
+    if (it != sent.end()) sent.erase(it);
+  }
+  PutVarint(payload, upsert_count);
+  payload += upserts;
+
+  // Whatever was sent before and is no longer ranked
+  PutVarint(payload, sent.size());
+  for (auto const& removed : sent) {
+    PutVarint(payload, removed.first);
+  }
+
+  PutVarint(payload, current.processes.size());
+  for (auto const& process : current.processes) {
+    PutVarint(payload, process.pid);
+  }
+  return Frame(full ? kSnapshot_ : kDelta_, payload);
+}
+
+// DONE: Read an unsigned LEB128 varint, advancing offset
+bool Protocol::GetVarint(string const& buffer, size_t& offset,
+                         uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && offset < buffer.size(); shift += 7) {
+    uint8_t byte = buffer[offset++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+// DONE: Read a length-prefixed string, advancing offset
+bool Protocol::GetString(string const& buffer, size_t& offset,
+                         string& value) {
+  uint64_t length;
+  if (!GetVarint(buffer, offset, length) || length > buffer.size() - offset)
+    return false;
+  value = buffer.substr(offset, length);
+  offset += length;
+  return true;
+}
+
+// DONE: Remove the first complete frame from a receive buffer
+Protocol::FrameStatus Protocol::NextFrame(string& buffer, FrameType& type,
+                                          string& payload) {
+  size_t offset{0};
+  uint64_t length;
+  if (!GetVarint(buffer, offset, length))
+    return buffer.size() >= 10 ? kFrameMalformed_ : kFrameIncomplete_;
+  if (length == 0 || length > kMaxFrameLength) return kFrameMalformed_;
+  if (buffer.size() - offset < length) return kFrameIncomplete_;
+
+  int value = static_cast<uint8_t>(buffer[offset]);
+  if (value < kSubscribe_ || value > kDelta_) return kFrameMalformed_;
+  type = static_cast<FrameType>(value);
+  payload = buffer.substr(offset + 1, length - 1);
+  buffer.erase(0, offset + length);
+  return kFrameComplete_;
+}
+
+// DONE: Decode the number of processes an aggregator subscribes to
+bool Protocol::DecodeSubscribe(string const& payload, int& top) {
+  size_t offset{0};
+  uint64_t value;
+  if (!GetVarint(payload, offset, value) || value > kMaxFrameLength)
+    return false;
+  top = value;
+  return true;
+}
+
+// DONE: Apply a snapshot or delta payload on top of the last snapshot
+// The snapshot is left untouched if the payload is malformed.
+bool Protocol::ApplyUpdate(string const& payload, bool full,
+                           Snapshot& snapshot) {
+  size_t offset{0};
+  HostRecord host;
+  uint64_t cpu, memory, total, running, uptime;
+  if (!GetString(payload, offset, host.name) ||
+      !GetVarint(payload, offset, cpu) ||
+      !GetVarint(payload, offset, memory) ||
+      !GetVarint(payload, offset, total) ||
+      !GetVarint(payload, offset, running) ||
+      !GetVarint(payload, offset, uptime))
+    return false;
+  host.cpu = cpu / 1e4;
+  host.memory = memory / 1e4;
+  host.total_processes = total;
+  host.running_processes = running;
+  host.uptime = uptime;
+
+  std::unordered_map<int, ProcessRecord> records;
+  if (!full) {
+    for (auto const& process : snapshot.processes) {
+      records[process.pid] = process;
+    }
+  }
+
+  uint64_t count;
+  if (!GetVarint(payload, offset, count)) return false;
+  for (uint64_t i = 0; i < count; i++) {
+    ProcessRecord process;
+    if (!DecodeProcess(payload, offset, process)) return false;
+    records[process.pid] = process;
+  }
+
+  if (!GetVarint(payload, offset, count)) return false;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t pid;
+    if (!GetVarint(payload, offset, pid)) return false;
+    records.erase(pid);
+  }
+
+  if (!GetVarint(payload, offset, count)) return false;
+  vector<ProcessRecord> processes;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t pid;
+    if (!GetVarint(payload, offset, pid)) return false;
+    auto it = records.find(pid);
+    if (it == records.end()) return false;
+    processes.push_back(it->second);
+  }
+
+  snapshot.host = host;
+  snapshot.processes = processes;
+  return true;
+}
+
+// DONE: Resolve an address into the socket addresses it stands for
+vector<Protocol::Endpoint> Protocol::Resolve(string const& address) {
+  vector<Endpoint> endpoints;
+  if (address.rfind("unix:", 0) == 0) {
+    string path = address.substr(5);
+    Endpoint endpoint{};
+    auto* local = reinterpret_cast<sockaddr_un*>(&endpoint.address);
+    if (path.empty() || path.size() >= sizeof(local->sun_path))
+      return endpoints;
+    local->sun_family = AF_UNIX;
+    std::strcpy(local->sun_path, path.c_str());
+    endpoint.length = sizeof(sockaddr_un);
+    endpoints.push_back(endpoint);
+    return endpoints;
+  }
+
+  size_t separator = address.rfind(':');
+  if (separator == string::npos) return endpoints;
+  string host = address.substr(0, separator);
+  string port = address.substr(separator + 1);
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+    host = host.substr(1, host.size() - 2);
+  // Without AI_PASSIVE an empty host is loopback, also when listening
+  struct addrinfo hints {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* results;
+  if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints,
+                  &results) != 0)
+    return endpoints;
+  for (auto* result = results; result != nullptr; result = result->ai_next) {
+    Endpoint endpoint{};
+    std::memcpy(&endpoint.address, result->ai_addr, result->ai_addrlen);
+    endpoint.length = result->ai_addrlen;
+    endpoints.push_back(endpoint);
+  }
+  freeaddrinfo(results);
+  return endpoints;
+}
+
+// DONE: Open a listening socket on every address that can be bound
+// An empty host resolves to both ::1 and 127.0.0.1, and a client may use
+// either, so binding only the first would leave the other refused.
+vector<int> Protocol::Listen(string const& address) {
+  vector<int> listeners;
+  for (auto const& endpoint : Resolve(address)) {
+    auto const* target = reinterpret_cast<sockaddr const*>(&endpoint.address);
+    int fd = socket(target->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) continue;
+    if (target->sa_family == AF_UNIX) {
+      // Replace the socket left behind by an agent that has exited, but not
+      // a live agent's socket or anything else
+      char const* path = reinterpret_cast<sockaddr_un const*>(target)->sun_path;
+      struct stat info;
+      if (::stat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool stale = probe >= 0 &&
+                     connect(probe, target, endpoint.length) != 0 &&
+                     errno == ECONNREFUSED;
+        if (probe >= 0) close(probe);
+        if (stale) unlink(path);
+      }
+    } else {
+      int reuse{1};
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    if (bind(fd, target, endpoint.length) == 0 &&
+        listen(fd, SOMAXCONN) == 0) {
+      listeners.push_back(fd);
+    } else {
+      close(fd);
+    }
+  }
+  return listeners;
+}
+
+// DONE: Start connecting to an endpoint without waiting for it
+// The connection may still be in progress; poll for POLLOUT and check
+// SO_ERROR before using it.
+int Protocol::Connect(Endpoint const& endpoint) {
+  auto const* target = reinterpret_cast<sockaddr const*>(&endpoint.address);
+  int fd = socket(target->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  0);
+  if (fd < 0) return -1;
+  if (connect(fd, target, endpoint.length) == 0 || errno == EINPROGRESS)
+    return fd;
+  close(fd);
+  return -1;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+#include "saturation.h"
+
+using std::vector;
+
+// DONE: Sample the saturation sources once per tick
+// Counters are kept as the change since the previous Update, so the first
+// sample reports zero rates.
+void Saturation::Update() {
+  auto now = std::chrono::steady_clock::now();
+  LinuxParser::StatCounters counters = LinuxParser::Counters();
+  vector<LinuxParser::Pressure> pressure;
+  for (auto const& resource : resources_) {
+    pressure.push_back(LinuxParser::PressureStall(resource));
+  }
+
+  if (sampled_) {
+    interval_ = std::chrono::duration<float>(now - time_).count();
+    context_switches_delta_ = counters.context_switches - context_switches_;
+    interrupts_delta_ = counters.interrupts - interrupts_;
+    for (size_t i = 0; i < pressure.size(); i++) {
+      some_stall_delta_[i] = pressure[i].some.total - pressure_[i].some.total;
+      full_stall_delta_[i] = pressure[i].full.total - pressure_[i].full.total;
+    }
+  }
+
+  time_ = now;
+  load_averages_ = LinuxParser::LoadAverages();
+  blocked_processes_ = counters.blocked_processes;
+  context_switches_ = counters.context_switches;
+  interrupts_ = counters.interrupts;
+  pressure_ = pressure;
+  sampled_ = true;
+}
+
+// DONE: Return the 1, 5 and 15 minute load averages
+vector<float> Saturation::LoadAverages() const { return load_averages_; }
+
+// DONE: Return the number of processes blocked on I/O
+int Saturation::BlockedProcesses() const { return blocked_processes_; }
+
+// DONE: Return the context switches per second over the last interval
+float Saturation::ContextSwitchRate() const {
+  if (interval_ == 0) return 0.0;
+  return context_switches_delta_ / interval_;
+}
+
+// DONE: Return the interrupts per second over the last interval
+float Saturation::InterruptRate() const {
+  if (interval_ == 0) return 0.0;
+  return interrupts_delta_ / interval_;
+}
+
+// DONE: Return the last Pressure Stall Information read for a resource
+LinuxParser::Pressure const& Saturation::Stall(
+    PressureResource resource) const {
+  return pressure_[resource];
+}
+
+// DONE: Return the share of the last interval in which some tasks stalled
+float Saturation::SomeStallRate(PressureResource resource) const {
+  if (interval_ == 0) return 0.0;
+  return some_stall_delta_[resource] / (interval_ * 1e6);
+}
+
+// DONE: Return the share of the last interval in which all tasks stalled
+float Saturation::FullStallRate(PressureResource resource) const {
+  if (interval_ == 0) return 0.0;
+  return full_stall_delta_[resource] / (interval_ * 1e6);
+}
@@ -2,11 +2,14 @@
 #include <cstddef>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "linux_parser.h"
 #include "process.h"
+#include "process_filter.h"
 #include "processor.h"
+#include "saturation.h"
 #include "system.h"
 
 using std::set;
@@ -23,16 +26,58 @@ format. cpp for formatting the uptime.*/
 // TODO: Return the system's CPU
 Processor& System::Cpu() { return cpu_; }
 
+// DONE: Return the system's saturation metrics
+Saturation& System::Load() { return load_; }
+
+// DONE: Return the criteria selecting which processes are sampled
+ProcessFilter& System::Filter() { return filter_; }
+
 // TODO: Return a container composed of the system's processes
+// Processes seen on the previous call are carried over so that their
+// per-interval counters can be computed; a PID with a new start time has been
+// reused and starts afresh. The filter is applied here, before
+// a process is sampled, so excluded processes cost at most a read of
+// /proc/<pid>/stat, see ProcessFilter for the criteria that read more.
 vector<Process>& System::Processes() {
-  processes_.clear();
+  std::unordered_map<int, size_t> previous;
+  for (size_t i = 0; i < processes_.size(); i++) {
+    previous[processes_[i].Pid()] = i;
+  }
+
+  vector<Process> processes;
   for (auto pid : LinuxParser::Pids()) {
-    processes_.emplace_back(pid);
+    if (!filter_.Admits(pid)) continue;
+    LinuxParser::ProcessStat stat = LinuxParser::Stat(pid);
+    if (!stat.available || !filter_.Admits(stat)) continue;
+
+    auto it = previous.find(pid);
+    if (it != previous.end() &&
+        processes_[it->second].StartTime() == stat.starttime) {
+      processes.push_back(std::move(processes_[it->second]));
+    } else {
+      processes.emplace_back(pid);
+    }
+    processes.back().Update(stat);
+  }
+  processes_ = std::move(processes);
+
+  if (sort_key_ == kWaitTimeSort_) {
+    std::sort(processes_.begin(), processes_.end(),
+              [](Process const& a, Process const& b) {
+                return a.WaitTime() > b.WaitTime();
+              });
+  } else {
+    std::sort(processes_.begin(), processes_.end());
   }
-  std::sort(processes_.begin(), processes_.end());
   return processes_;
 }
 
+// DONE: Choose the ordering used by Processes
+void System::SortBy(SortKey key) { sort_key_ = key; }
+
+// DONE: Return the ordering used by Processes
+System::SortKey System::SortOrder() const { return sort_key_; }
+
 // TODO: Return the system's kernel identifier (string)
 std::string System::Kernel() { return LinuxParser::Kernel(); }
 
@@ -0,0 +1,109 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "aggregator.h"
+
+using std::string;
+using std::vector;
+
+// Runs two agents on localhost against the fake /proc roots in
+// test/fixtures and checks the ranking merged by an Aggregator.
+// Usage: agents_test <monitor binary> <fixtures directory>
+namespace {
+pid_t StartAgent(string const& monitor, string const& address,
+                 string const& name, string const& root) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    execl(monitor.c_str(), monitor.c_str(), "--agent", address.c_str(),
+          "--name", name.c_str(), "--proc", root.c_str(),
+          static_cast<char*>(nullptr));
+    _exit(127);
+  }
+  return pid;
+}
+
+bool WaitForSocket(string const& path) {
+  for (int i = 0; i < 50; i++) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  return false;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "usage: agents_test <monitor> <fixtures>\n";
+    return 2;
+  }
+  string monitor{argv[1]};
+  string fixtures{argv[2]};
+  char directory[] = "/tmp/agents_test_XXXXXX";
+  if (mkdtemp(directory) == nullptr) return 2;
+  string socket_a = string(directory) + "/a.sock";
+  string socket_b = string(directory) + "/b.sock";
+
+  vector<pid_t> agents{
+      StartAgent(monitor, "unix:" + socket_a, "a", fixtures + "/proc_a"),
+      StartAgent(monitor, "unix:" + socket_b, "b", fixtures + "/proc_b")};
+  bool ready = WaitForSocket(socket_a) && WaitForSocket(socket_b);
+
+  // Ranked by CPU over both roots: utime over the same lifetime
+  vector<std::pair<string, int>> const expected{
+      {"b", 202}, {"a", 100}, {"b", 200}, {"a", 102}, {"b", 201}, {"a", 101}};
+  vector<Aggregator::HostProcess> top;
+  Aggregator aggregator({"unix:" + socket_a, "unix:" + socket_b}, 10);
+  for (int i = 0; ready && i < 10 && top.size() < expected.size(); i++) {
+    aggregator.Poll(500);
+    top = aggregator.Top(10);
+  }
+
+  int failures{0};
+  if (top.size() != expected.size()) {
+    std::cerr << "FAIL: merged " << top.size() << " processes, expected "
+              << expected.size() << "\n";
+    failures++;
+  }
+  for (size_t i = 0; i < top.size() && i < expected.size(); i++) {
+    if (top[i].host != expected[i].first ||
+        top[i].process.pid != expected[i].second) {
+      std::cerr << "FAIL: rank " << i << " is " << top[i].host << "/"
+                << top[i].process.pid << ", expected " << expected[i].first
+                << "/" << expected[i].second << "\n";
+      failures++;
+    }
+  }
+  if (!top.empty() && top[0].process.command != "/usr/bin/zeta --fixture") {
+    std::cerr << "FAIL: command is \"" << top[0].process.command << "\"\n";
+    failures++;
+  }
+  // Every fixture process starts 1000 clock ticks after boot
+  if (!top.empty() && top[0].process.start != 1000 / sysconf(_SC_CLK_TCK)) {
+    std::cerr << "FAIL: start is " << top[0].process.start << "\n";
+    failures++;
+  }
+  if (aggregator.Top(3).size() != 3) {
+    std::cerr << "FAIL: Top(3) is not truncated to 3\n";
+    failures++;
+  }
+
+  for (pid_t agent : agents) {
+    kill(agent, SIGTERM);
+    waitpid(agent, nullptr, 0);
+  }
+  unlink(socket_a.c_str());
+  unlink(socket_b.c_str());
+  rmdir(directory);
+  if (failures == 0) std::cout << "agents_test: all checks passed\n";
+  return failures == 0 ? 0 : 1;
+}
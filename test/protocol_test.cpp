@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+using Protocol::ProcessRecord;
+using Protocol::Snapshot;
+using std::string;
+
+namespace {
+int failures{0};
+
+void Check(bool condition, string const& what) {
+  if (!condition) {
+    std::cerr << "FAIL: " << what << "\n";
+    failures++;
+  }
+}
+
+// Values are chosen to survive the quantization on the wire exactly
+Snapshot MakeSnapshot(std::vector<ProcessRecord> const& processes) {
+  Snapshot snapshot;
+  snapshot.host.name = "host";
+  snapshot.host.cpu = 0.5;
+  snapshot.host.memory = 0.25;
+  snapshot.host.total_processes = 42;
+  snapshot.host.running_processes = 2;
+  snapshot.host.uptime = 5000;
+  snapshot.processes = processes;
+  return snapshot;
+}
+
+ProcessRecord MakeProcess(int pid, float cpu) {
+  return {pid, cpu, 10.5, 1000 + pid, "root", "cmd " + std::to_string(pid)};
+}
+
+bool Equal(Snapshot const& a, Snapshot const& b) {
+  if (a.host.name != b.host.name || a.host.cpu != b.host.cpu ||
+      a.host.memory != b.host.memory ||
+      a.host.total_processes != b.host.total_processes ||
+      a.host.running_processes != b.host.running_processes ||
+      a.host.uptime != b.host.uptime ||
+      a.processes.size() != b.processes.size())
+    return false;
+  for (size_t i = 0; i < a.processes.size(); i++) {
+    ProcessRecord const& x = a.processes[i];
+    ProcessRecord const& y = b.processes[i];
+    if (x.pid != y.pid || x.cpu != y.cpu || x.ram != y.ram ||
+        x.start != y.start || x.user != y.user || x.command != y.command)
+      return false;
+  }
+  return true;
+}
+
+// Decodes a single frame and applies it to a snapshot
+bool Receive(string frame, Snapshot& snapshot) {
+  Protocol::FrameType type;
+  string payload;
+  if (Protocol::NextFrame(frame, type, payload) != Protocol::kFrameComplete_ ||
+      !frame.empty())
+    return false;
+  return Protocol::ApplyUpdate(payload, type == Protocol::kSnapshot_,
+                               snapshot);
+}
+
+void TestVarint() {
+  for (uint64_t value : {uint64_t{0}, uint64_t{127}, uint64_t{128},
+                         uint64_t{1} << 35, UINT64_MAX}) {
+    string buffer;
+    Protocol::PutVarint(buffer, value);
+    size_t offset{0};
+    uint64_t decoded;
+    Check(Protocol::GetVarint(buffer, offset, decoded) && decoded == value &&
+              offset == buffer.size(),
+          "varint round trip of " + std::to_string(value));
+  }
+  string truncated{"\x80"};
+  size_t offset{0};
+  uint64_t decoded;
+  Check(!Protocol::GetVarint(truncated, offset, decoded), "truncated varint");
+}
+
+void TestFrames() {
+  string buffer = Protocol::EncodeSubscribe(10);
+  string second = Protocol::EncodeSubscribe(20);
+  Protocol::FrameType type;
+  string payload;
+  int top;
+
+  string partial = buffer.substr(0, buffer.size() - 1);
+  Check(Protocol::NextFrame(partial, type, payload) ==
+            Protocol::kFrameIncomplete_,
+        "partial frame is incomplete");
+
+  buffer += second;
+  Check(Protocol::NextFrame(buffer, type, payload) ==
+                Protocol::kFrameComplete_ &&
+            type == Protocol::kSubscribe_ &&
+            Protocol::DecodeSubscribe(payload, top) && top == 10,
+        "first of two frames");
+  Check(Protocol::NextFrame(buffer, type, payload) ==
+                Protocol::kFrameComplete_ &&
+            Protocol::DecodeSubscribe(payload, top) && top == 20 &&
+            buffer.empty(),
+        "second of two frames");
+
+  string unknown = Protocol::Frame(static_cast<Protocol::FrameType>(9), "");
+  Check(Protocol::NextFrame(unknown, type, payload) ==
+            Protocol::kFrameMalformed_,
+        "unknown frame type is malformed");
+}
+
+void TestSnapshot() {
+  Snapshot sent = MakeSnapshot(
+      {MakeProcess(1, 0.75), MakeProcess(2, 0.5), MakeProcess(3, 0.25)});
+  Snapshot received;
+  Check(Receive(Protocol::EncodeUpdate({}, sent, true), received) &&
+            Equal(sent, received),
+        "full snapshot round trip");
+}
+
+// Insert 4, change and re-rank 3, drop 2, keep 1 as it was
+void TestDelta() {
+  Snapshot previous = MakeSnapshot(
+      {MakeProcess(1, 0.75), MakeProcess(2, 0.5), MakeProcess(3, 0.25)});
+  Snapshot current =
+      MakeSnapshot({MakeProcess(3, 1.5), MakeProcess(1, 0.75),
+                    MakeProcess(4, 0.125)});
+  current.host.uptime = 5001;
+
+  Snapshot received;
+  Check(Receive(Protocol::EncodeUpdate({}, previous, true), received),
+        "snapshot before delta");
+  string delta = Protocol::EncodeUpdate(previous, current, false);
+  Check(Receive(delta, received) && Equal(current, received),
+        "delta insert, change, drop and re-rank");
+  Check(delta.size() < Protocol::EncodeUpdate({}, current, true).size(),
+        "delta leaves out unchanged records");
+
+  string unchanged = Protocol::EncodeUpdate(current, current, false);
+  Check(Receive(unchanged, received) && Equal(current, received),
+        "delta without changes");
+}
+
+void TestMalformed() {
+  Snapshot sent = MakeSnapshot({MakeProcess(1, 0.75), MakeProcess(2, 0.5)});
+  Snapshot received;
+  Receive(Protocol::EncodeUpdate({}, sent, true), received);
+
+  // A delta ranking a PID the receiver has never seen: host fields, no
+  // records, no removals, then a ranking of PID 9, see EncodeUpdate
+  string unknown;
+  Protocol::PutString(unknown, "host");
+  for (int i = 0; i < 5; i++) Protocol::PutVarint(unknown, 1);
+  Protocol::PutVarint(unknown, 0);
+  Protocol::PutVarint(unknown, 0);
+  Protocol::PutVarint(unknown, 1);
+  Protocol::PutVarint(unknown, 9);
+  Check(!Protocol::ApplyUpdate(unknown, false, received) &&
+            Equal(sent, received),
+        "ranking an unknown PID leaves the snapshot untouched");
+
+  Protocol::FrameType type;
+  string body;
+  string full = Protocol::EncodeUpdate({}, sent, true);
+  Protocol::NextFrame(full, type, body);
+  Check(!Protocol::ApplyUpdate(body.substr(0, body.size() / 2), false,
+                               received) &&
+            Equal(sent, received),
+        "half a payload leaves the snapshot untouched");
+}
+}  // namespace
+
+int main() {
+  TestVarint();
+  TestFrames();
+  TestSnapshot();
+  TestDelta();
+  TestMalformed();
+  if (failures == 0) std::cout << "protocol_test: all checks passed\n";
+  return failures == 0 ? 0 : 1;
+}